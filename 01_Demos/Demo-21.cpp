@@ -0,0 +1,203 @@
+/**############################################################################
+#
+# @Program		DEMO #21
+# @File			Demo-21.cpp
+# @Description	Demo #21 made by using Consoler game framework.
+#
+# @Author		Srdjan Susnic
+# @Website		https://www.askforgametask.com
+# @Github		https://www.github.com/ssusnic
+# @Youtube		https://www.youtube.com/ssusnic
+#
+# Copyright (C) 2021 Ask For Game Task
+#
+# This program is protected by GNU General Public License version 3.
+# If you use it, you must attribute me.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You can view this license here:
+# https://opensource.org/licenses/GPL-3.0
+#
+#############################################################################*/
+
+// include interface of the Consoler framework and its extension
+#include "ConsolerExt.h"
+
+// benchmarks of the demo (SPACE switches to the next one)
+enum {
+	SCENE_CIRCLES,
+	SCENE_MAZE,
+	SCENE_COUNT
+};
+
+// circle structure used by the benchmark
+struct Circle {
+	int x, y, r;
+	short color;
+};
+
+/******************************************************************************
+*
+* Game class - inherits ConsolerExt class.
+*
+******************************************************************************/
+
+class Game : public ConsolerExt
+{
+private:
+	Sprite *fontSmall = new Sprite(BLACK);
+
+	Key keySpace = {VK_SPACE};
+
+	int scene = SCENE_CIRCLES;
+
+	// filled circles drawn by both circle functions
+	vector<Circle> circles;
+
+	// total microseconds and number of measured frames
+	double oldCircleTime = 0;
+	double newCircleTime = 0;
+	int circleFrames = 0;
+
+	// total microseconds and number of measured maze fills
+	double mazeTime = 0;
+	int mazeFrames = 0;
+
+public:
+	//=========================================================================
+	// Inherits ConsolerExt constructor.
+	//=========================================================================
+	using ConsolerExt::ConsolerExt;
+
+	//=========================================================================
+	// Sets up the game objects.
+	//=========================================================================
+	void Setup() override
+	{
+		// initialize random seed
+		srand(time(NULL));
+
+		// load fonts
+		fontSmall->Load(L".\\assets\\fnt_5x7.bin", 5, 7);
+
+		// generate the benchmark circles
+		for (int i = 0; i < 200; i++){
+			circles.push_back({
+				Util::Rand(0, GetCanvasW()),
+				Util::Rand(20, GetCanvasH()),
+				Util::Rand(2, 40),
+				(short)Util::Rand(1, 15)
+			});
+		}
+	}
+
+	//=========================================================================
+	// Updates the main game loop.
+	//=========================================================================
+	void Update() override
+	{
+		// handle inputs
+		HandleKey(&keySpace);
+
+		if (keySpace.isPressed){
+			scene = (scene + 1) % SCENE_COUNT;
+			oldCircleTime = newCircleTime = mazeTime = 0;
+			circleFrames = mazeFrames = 0;
+		}
+
+		// render scene
+		ClearScreen(BLACK);
+
+		if (scene == SCENE_CIRCLES) DrawCircles();
+		if (scene == SCENE_MAZE) DrawMaze();
+
+		// set bitmap text properties
+		SetTextProperty(fontSmall, LEFT, 0, WHITE, BLACK);
+		DrawBitmapText(L"SPACE: NEXT BENCHMARK", 2, 2);
+	}
+
+	//=========================================================================
+	// Compares Consoler::DrawCircle with the span based DrawCircle.
+	//=========================================================================
+	void DrawCircles()
+	{
+		auto t1 = chrono::steady_clock::now();
+
+		for (const Circle &c : circles)
+			Consoler::DrawCircle(c.x, c.y, c.r, WHITE, c.color);
+
+		auto t2 = chrono::steady_clock::now();
+
+		for (const Circle &c : circles)
+			DrawCircle(c.x, c.y, c.r, WHITE, c.color);
+
+		auto t3 = chrono::steady_clock::now();
+
+		oldCircleTime += chrono::duration<double, micro>(t2 - t1).count();
+		newCircleTime += chrono::duration<double, micro>(t3 - t2).count();
+		circleFrames++;
+
+		double oldTime = oldCircleTime / circleFrames;
+		double newTime = newCircleTime / circleFrames;
+
+		SetTextProperty(fontSmall, LEFT, 0, WHITE, BLACK);
+		DrawBitmapText(L"200 FILLED CIRCLES PER FRAME", 2, 12);
+		DrawBitmapText(L"OLD: " + to_wstring((int)oldTime) + L" US", 2, 22);
+		DrawBitmapText(L"NEW: " + to_wstring((int)newTime) + L" US", 2, 32);
+
+		if (newTime > 0)
+			DrawBitmapText(L"SPEEDUP: " + to_wstring(oldTime / newTime), 2, 42);
+	}
+
+	//=========================================================================
+	// Fills a serpentine maze with a single FloodFill.
+	//=========================================================================
+	void DrawMaze()
+	{
+		int w = GetCanvasW();
+		int h = GetCanvasH();
+
+		// horizontal walls with a gap at alternating ends
+		for (int y = 20, i = 0; y < h - 2; y += 4, i++){
+			DrawRectangle(0, y, w, 2, DARK_GREY);
+			DrawRectangle((i % 2) ? 0 : w - 8, y, 8, 2, BLACK);
+		}
+
+		// fill the whole corridor from its bottom end
+		auto t1 = chrono::steady_clock::now();
+		FloodFill(0, h - 1, DARK_CYAN);
+		auto t2 = chrono::steady_clock::now();
+
+		mazeTime += chrono::duration<double, micro>(t2 - t1).count();
+		mazeFrames++;
+
+		SetTextProperty(fontSmall, LEFT, 0, WHITE, BLACK);
+		DrawBitmapText(L"MAZE FLOOD FILL", 2, 12);
+		DrawBitmapText(L"TIME: " + to_wstring((int)(mazeTime / mazeFrames)) + L" US", 120, 12);
+	}
+};
+
+/******************************************************************************
+*
+* Main program
+*
+******************************************************************************/
+
+int main(){
+	// initialize a new game
+	Game game(L"Consoler Demo", 320, 200, 1, 1, 60);
+
+	// run the main game loop
+	game.Run();
+
+	return 0;
+}
\ No newline at end of file
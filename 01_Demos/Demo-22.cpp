@@ -0,0 +1,191 @@
+/**############################################################################
+#
+# @Program		DEMO #22
+# @File			Demo-22.cpp
+# @Description	Demo #22 made by using Consoler game framework.
+#
+# @Author		Srdjan Susnic
+# @Website		https://www.askforgametask.com
+# @Github		https://www.github.com/ssusnic
+# @Youtube		https://www.youtube.com/ssusnic
+#
+# Copyright (C) 2021 Ask For Game Task
+#
+# This program is protected by GNU General Public License version 3.
+# If you use it, you must attribute me.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You can view this license here:
+# https://opensource.org/licenses/GPL-3.0
+#
+#############################################################################*/
+
+// include interface of the Consoler framework and its extension
+#include "ConsolerExt.h"
+
+// scenes of the demo (SPACE switches to the next one)
+enum {
+	SCENE_SHAPES,
+	SCENE_LAYERS,
+	SCENE_COUNT
+};
+
+/******************************************************************************
+*
+* Game class - inherits ConsolerExt class.
+*
+******************************************************************************/
+
+class Game : public ConsolerExt
+{
+private:
+	Sprite *fontSmall = new Sprite(BLACK);
+
+	Key keySpace = {VK_SPACE};
+
+	int scene = SCENE_SHAPES;
+	float elapsed = 0;
+
+public:
+	//=========================================================================
+	// Inherits ConsolerExt constructor.
+	//=========================================================================
+	using ConsolerExt::ConsolerExt;
+
+	//=========================================================================
+	// Sets up the game objects.
+	//=========================================================================
+	void Setup() override
+	{
+		// load fonts
+		fontSmall->Load(L".\\assets\\fnt_5x7.bin", 5, 7);
+
+		// create a static background layer and a dynamic layer on top of it
+		AddLayer("sky", 0, true);
+		AddLayer("balls", 1);
+	}
+
+	//=========================================================================
+	// Updates the main game loop.
+	//=========================================================================
+	void Update() override
+	{
+		// handle inputs
+		HandleKey(&keySpace);
+
+		if (keySpace.isPressed) scene = (scene + 1) % SCENE_COUNT;
+
+		elapsed += min(GetElapsedTime(), 0.05f);
+
+		// render scene
+		ClearScreen(BLACK);
+
+		if (scene == SCENE_SHAPES) DrawShapes();
+		if (scene == SCENE_LAYERS) DrawLayers();
+
+		// set bitmap text properties
+		SetTextProperty(fontSmall, LEFT, 0, WHITE, BLACK);
+		DrawBitmapText(L"SPACE: NEXT SCENE", 2, 2);
+	}
+
+	//=========================================================================
+	// Draws lines, polylines, polygons, circles and arcs.
+	//=========================================================================
+	void DrawShapes()
+	{
+		int cx = GetCenterX();
+		int cy = GetCenterY();
+
+		// fan of lines (partly outside of the canvas to exercise clipping)
+		for (int i = 0; i < 36; i++){
+			float a = elapsed + i * 3.14159f / 18;
+			DrawLine(cx, cy, cx + cos(a) * 250, cy + sin(a) * 250, 1 + i % 15);
+		}
+
+		// self-intersecting star filled with both fill rules
+		vector<Point> star;
+		for (int i = 0; i < 5; i++){
+			float a = -elapsed + i * 4 * 3.14159f / 5;
+			star.push_back({70 + (int)(cos(a) * 50), cy + (int)(sin(a) * 50)});
+		}
+
+		DrawPolygon(star, YELLOW, WHITE, EVEN_ODD);
+
+		for (Point &p : star) p.x += 180;
+		DrawPolygon(star, RED, WHITE, NON_ZERO);
+
+		// pulsing circle, ellipse and arc in the middle
+		int r = 20 + (int)(10 * sin(elapsed * 3));
+		DrawCircle(cx, cy, r, WHITE, DARK_BLUE);
+		DrawEllipse(cx, cy, r / 2, r + 10, CYAN);
+		DrawArc(cx, cy, r + 5, r + 5, elapsed * 90, elapsed * 90 + 180, GREEN);
+	}
+
+	//=========================================================================
+	// Draws a static and a dynamic layer and lights them with a spotlight
+	// made with the stencil.
+	//=========================================================================
+	void DrawLayers()
+	{
+		int w = GetCanvasW();
+		int h = GetCanvasH();
+
+		// the sky layer is rasterized only once
+		if (BeginLayer("sky")){
+			DrawRectangle(0, 0, w, h / 2, DARK_BLUE);
+			DrawRectangle(0, h / 2, w, h / 2, DARK_GREEN);
+			DrawPolygon({{0, h / 2}, {80, 40}, {160, h / 2}}, DARK_GREY);
+			DrawPolygon({{120, h / 2}, {220, 60}, {320, h / 2}}, GREY);
+			DrawCircle(270, 30, 15, YELLOW, YELLOW);
+		}
+		EndLayer();
+
+		// the balls layer is redrawn every frame
+		if (BeginLayer("balls")){
+			for (int i = 0; i < 8; i++){
+				int x = (int)(w / 2 + cos(elapsed + i) * (40 + i * 12));
+				int y = (int)(h / 2 + 40 + sin(elapsed * 2 + i) * 20);
+				DrawCircle(x, y, 6 + i, WHITE, 9 + i % 6);
+			}
+		}
+		EndLayer();
+
+		CompositeLayers();
+
+		// write a moving spotlight into the stencil
+		ClearStencil();
+		SetStencilMode(STENCIL_WRITE);
+		DrawCircle(w / 2 + (int)(cos(elapsed) * 100), h / 2, 50, WHITE, WHITE);
+
+		// cover everything outside of the spotlight
+		SetStencilMode(STENCIL_TEST_INV);
+		DrawRectangle(0, 0, w, h, BLACK);
+		SetStencilMode(STENCIL_OFF);
+	}
+
+};
+
+/******************************************************************************
+*
+* Main program
+*
+******************************************************************************/
+
+int main(){
+	// initialize a new game
+	Game game(L"Consoler Demo", 320, 200, 1, 1, 60);
+
+	// run the main game loop
+	game.Run();
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,2250 @@
+/**############################################################################
+#
+# @Program		CONSOLER v0.001
+# @File			ConsolerExt.h (header file: header-only extension of Consoler)
+# @Description	A game framework for making games in C++ for Windows Console.
+#
+# @Author		Srdjan Susnic
+# @Website		https://www.askforgametask.com
+# @Github		https://www.github.com/ssusnic
+# @Youtube		https://www.youtube.com/ssusnic
+#
+# Copyright (C) 2021 Ask For Game Task
+#
+# This program is protected by GNU General Public License version 3.
+# If you use it, you must attribute me.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You can view this license here:
+# https://opensource.org/licenses/GPL-3.0
+#
+#############################################################################*/
+
+//=============================================================================
+// ConsolerExt adds extra drawing primitives on top of the Consoler class.
+// It is header-only and does not change the layout of the Consoler class,
+// so it works with both Consoler.dll and ConsolerStatic.lib.
+//
+// To use it, inherit your Game class from ConsolerExt instead of Consoler:
+//
+//		class Game : public ConsolerExt
+//		{
+//		public:
+//			using ConsolerExt::ConsolerExt;
+//			...
+//		};
+//
+// All shapes are rasterized as horizontal spans clipped once to the active
+// clip rectangle (see PushClip), so each span is written to the canvas with
+// a single call instead of one call per pixel.
+//=============================================================================
+
+#ifndef CONSOLER_EXT_H
+#define CONSOLER_EXT_H
+
+#include "Consoler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <tuple>
+
+// Stencil modes
+enum {
+	STENCIL_OFF		,	// draw normally
+	STENCIL_WRITE	,	// set stencil bits instead of drawing
+	STENCIL_ERASE	,	// clear stencil bits instead of drawing
+	STENCIL_TEST	,	// draw only where the stencil bit is set
+	STENCIL_TEST_INV	// draw only where the stencil bit is not set
+};
+
+// Polygon fill rules
+enum {
+	EVEN_ODD	,
+	NON_ZERO
+};
+
+// Point structure
+struct Point {
+	int x = 0, y = 0;
+};
+
+// Color remap table used by ConsolerExt::DrawSprite
+// (a NONE entry makes pixels of that color transparent)
+struct ColorMap {
+	short colors[16] = {
+		0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+	};
+
+	short &operator[](int i) { return colors[i]; }
+
+	//=========================================================================
+	// Returns a map that darkens every color by the given number of steps
+	// along the console light ramps (e.g. WHITE -> GREY -> DARK_GREY ->
+	// BLACK, RED -> DARK_RED -> BLACK). 3 steps turn everything black.
+	//=========================================================================
+	static ColorMap Darken(int steps)
+	{
+		static const short darker[16] = {
+			BLACK, BLACK, BLACK, BLACK, BLACK, BLACK, BLACK, DARK_GREY,
+			BLACK, DARK_BLUE, DARK_GREEN, DARK_CYAN,
+			DARK_RED, DARK_MAGENTA, DARK_YELLOW, GREY
+		};
+
+		ColorMap map;
+		for (int i = 0; i < 16; i++){
+			for (int s = 0; s < steps; s++)
+				map.colors[i] = darker[map.colors[i]];
+		}
+
+		return map;
+	}
+};
+
+// Locked render target rows returned by ConsolerExt::LockCanvas
+struct CanvasLock {
+	short *pixels = nullptr;	// pixel (0, 0) of the render target
+	int stride = 0;				// number of pixels between two rows
+	int y1 = 0, y2 = 0;			// locked rows (y2 is exclusive)
+
+	// returns the pixels of the given row
+	short *Row(int y) { return pixels + y * stride; }
+};
+
+/******************************************************************************
+*
+* CommandBuffer class
+*
+******************************************************************************/
+
+class CommandBuffer
+{
+public:
+	// types of the recorded draw calls
+	enum {
+		CMD_PIXEL,
+		CMD_LINE,
+		CMD_RECT,
+		CMD_ELLIPSE,
+		CMD_SPRITE,
+		CMD_TEXT
+	};
+
+	// a single recorded draw call
+	struct Command {
+		short type;
+		short color1;			// color / stroke color / fore color
+		short color2;			// fill color / back color
+		short align;			// text alignment
+		int a, b, c, d;			// coords, sizes or radii
+		Sprite *sprite;			// sprite to draw (CMD_SPRITE)
+		int text;				// index of the text (CMD_TEXT)
+	};
+
+	// the recorded draw calls in submission order
+	vector<Command> commands;
+
+	// texts used by the bitmap text commands
+	vector<wstring> texts;
+
+	// bounding box of the shape commands (x2 and y2 are exclusive,
+	// unlike the inclusive Rect of sprite bounds and DrawRects)
+	Rect bound;
+
+private:
+	// true if the buffer holds a valid recording
+	bool isRecorded = false;
+
+	// key of the inputs used for the current recording
+	uint64_t inputKey = 0;
+
+public:
+	//=========================================================================
+	// Returns true if the buffer must be recorded for the given inputs.
+	// The buffer is cleared when the key differs from the recorded one,
+	// so record the draw calls right after this function returns true:
+	//
+	//		if (buffer->Record(score)){
+	//			buffer->DrawRectangle(...);
+	//			...
+	//		}
+	//		DrawCommandBuffer(buffer);
+	//=========================================================================
+	bool Record(uint64_t key = 0)
+	{
+		if (isRecorded && key == inputKey) return false;
+
+		Clear();
+		isRecorded = true;
+		inputKey = key;
+
+		return true;
+	}
+
+	//=========================================================================
+	// Invalidates the buffer, so the next Record call returns true.
+	//=========================================================================
+	void Invalidate()
+	{
+		isRecorded = false;
+	}
+
+	//=========================================================================
+	// Removes all recorded draw calls.
+	//=========================================================================
+	void Clear()
+	{
+		commands.clear();
+		texts.clear();
+		bound = Rect();
+	}
+
+	//=========================================================================
+	// Records a pixel.
+	//=========================================================================
+	void DrawPixel(int x, int y, short color)
+	{
+		Add(CMD_PIXEL, x, y, 0, 0, color);
+		Extend(x, y, x + 1, y + 1);
+	}
+
+	//=========================================================================
+	// Records a line.
+	//=========================================================================
+	void DrawLine(int x1, int y1, int x2, int y2, short color)
+	{
+		Add(CMD_LINE, x1, y1, x2, y2, color);
+		Extend(min(x1, x2), min(y1, y2), max(x1, x2) + 1, max(y1, y2) + 1);
+	}
+
+	//=========================================================================
+	// Records a rectangle at XY using its width and height.
+	//=========================================================================
+	void DrawRectangle(int x, int y, int width, int height, short color)
+	{
+		if (width <= 0 || height <= 0) return;
+
+		Add(CMD_RECT, x, y, width, height, color);
+		Extend(x, y, x + width, y + height);
+	}
+
+	//=========================================================================
+	// Records a circle.
+	//=========================================================================
+	void DrawCircle(
+		int cx, int cy, int radius,
+		short strokeColor, short fillColor = NONE
+	){
+		DrawEllipse(cx, cy, radius, radius, strokeColor, fillColor);
+	}
+
+	//=========================================================================
+	// Records an ellipse.
+	//=========================================================================
+	void DrawEllipse(
+		int cx, int cy, int rx, int ry,
+		short strokeColor, short fillColor = NONE
+	){
+		if (rx < 0 || ry < 0) return;
+
+		Add(CMD_ELLIPSE, cx, cy, rx, ry, strokeColor, fillColor);
+		Extend(cx - rx, cy - ry, cx + rx + 1, cy + ry + 1);
+	}
+
+	//=========================================================================
+	// Records a sprite at the given XY coordinate.
+	//=========================================================================
+	void DrawSprite(Sprite *sprite, int x, int y, short fgColor = NONE)
+	{
+		Command &cmd = Add(CMD_SPRITE, x, y, 0, 0, fgColor);
+		cmd.sprite = sprite;
+	}
+
+	//=========================================================================
+	// Records a bitmap text at XY position.
+	//=========================================================================
+	void DrawBitmapText(
+		wstring text, int x, int y,
+		short align, short fgColor = NONE, short bgColor = NONE
+	){
+		Command &cmd = Add(CMD_TEXT, x, y, 0, 0, fgColor, bgColor);
+		cmd.align = align;
+		cmd.text = texts.size();
+
+		texts.push_back(text);
+	}
+
+private:
+	//=========================================================================
+	// Adds a new command to the buffer.
+	//=========================================================================
+	Command &Add(
+		short type, int a, int b, int c, int d,
+		short color1, short color2 = NONE
+	){
+		commands.push_back({type, color1, color2, LEFT, a, b, c, d, nullptr, 0});
+		return commands.back();
+	}
+
+	//=========================================================================
+	// Extends the bounding box of the shape commands.
+	//=========================================================================
+	void Extend(int x1, int y1, int x2, int y2)
+	{
+		bool isEmpty = (bound.x1 >= bound.x2 || bound.y1 >= bound.y2);
+
+		bound.x1 = isEmpty ? x1 : min(bound.x1, x1);
+		bound.y1 = isEmpty ? y1 : min(bound.y1, y1);
+		bound.x2 = isEmpty ? x2 : max(bound.x2, x2);
+		bound.y2 = isEmpty ? y2 : max(bound.y2, y2);
+		bound.cx = (bound.x1 + bound.x2) / 2;
+		bound.cy = (bound.y1 + bound.y2) / 2;
+	}
+};
+
+/******************************************************************************
+*
+* Surface class
+*
+******************************************************************************/
+
+class Surface
+{
+public:
+	// surface size
+	int width = 0;
+	int height = 0;
+
+	// transparent color (NONE pixels are always transparent)
+	short transparent;
+
+	// array of pixel colors (row by row)
+	vector<short> pixels;
+
+	//=========================================================================
+	// Constructor - creates a surface with all pixels set to NONE.
+	//=========================================================================
+	Surface(int w = 0, int h = 0, short transparentColor = NONE)
+	{
+		transparent = transparentColor;
+		Create(w, h);
+	}
+
+	//=========================================================================
+	// Resizes the surface and sets all pixels to NONE.
+	//=========================================================================
+	void Create(int w, int h)
+	{
+		width = max(w, 0);
+		height = max(h, 0);
+		pixels.assign(width * height, NONE);
+	}
+
+	//=========================================================================
+	// Sets all pixels to the given color.
+	//=========================================================================
+	void Clear(short color = NONE)
+	{
+		fill(pixels.begin(), pixels.end(), color);
+	}
+
+	//=========================================================================
+	// Returns the pixels of the given row.
+	//=========================================================================
+	short *Row(int y)
+	{
+		return pixels.data() + y * width;
+	}
+
+	//=========================================================================
+	// Returns the color of a pixel (NONE if it is outside of the surface).
+	//=========================================================================
+	short GetPixelColor(int x, int y)
+	{
+		if (x < 0 || y < 0 || x >= width || y >= height) return NONE;
+		return pixels[y * width + x];
+	}
+
+	//=========================================================================
+	// Returns true if the given color is transparent.
+	//=========================================================================
+	bool IsTransparent(short color)
+	{
+		return color == NONE || color == transparent;
+	}
+
+	//=========================================================================
+	// Copies the current frame of a sprite into this surface.
+	// Transparent sprite pixels become NONE.
+	//=========================================================================
+	void LoadFromSprite(Sprite *sprite)
+	{
+		Create(sprite->GetW(), sprite->GetH());
+
+		for (int y = 0; y < height; y++){
+			short *row = Row(y);
+
+			for (int x = 0; x < width; x++){
+				short color = sprite->GetPixelColor(x, y);
+				row[x] = sprite->IsTransparent(color) ? NONE : color;
+			}
+		}
+	}
+
+	//=========================================================================
+	// Saves the surface as a sprite binary file (the same format as the
+	// files made by the image converter tool).
+	// NONE pixels are saved in the transparent color (BLACK if not set).
+	//=========================================================================
+	bool Save(wstring fileName)
+	{
+		FILE *f = _wfopen(fileName.c_str(), L"wb");
+		if (f == nullptr) return false;
+
+		vector<short> data(pixels);
+		short empty = (transparent == NONE) ? (short)BLACK : transparent;
+		replace(data.begin(), data.end(), (short)NONE, empty);
+
+		fwrite(&width, sizeof(int), 1, f);
+		fwrite(&height, sizeof(int), 1, f);
+		fwrite(data.data(), sizeof(short), data.size(), f);
+		fclose(f);
+
+		return true;
+	}
+
+	//=========================================================================
+	// Converts the surface to a sprite by saving it to a binary file
+	// and loading that file into the sprite.
+	//=========================================================================
+	bool SaveToSprite(Sprite *sprite, wstring fileName)
+	{
+		return Save(fileName) && sprite->Load(fileName, width, height);
+	}
+};
+
+/******************************************************************************
+*
+* SpriteCache class
+*
+******************************************************************************/
+
+class SpriteCache
+{
+public:
+	Sprite *sprite = nullptr;	// cached sprite
+
+	//=========================================================================
+	// Creates an empty cache for the given sprite. The cache is owned by
+	// the caller and must live no longer than the sprite.
+	//=========================================================================
+	SpriteCache(Sprite *cachedSprite = nullptr)
+	{
+		sprite = cachedSprite;
+	}
+
+	//=========================================================================
+	// Returns the pixels of the current sprite frame. They are read from
+	// the sprite only the first time the frame is requested.
+	//=========================================================================
+	Surface *GetFrame()
+	{
+		auto key = make_tuple(sprite->GetFrame(), sprite->GetW(), sprite->GetH());
+
+		auto it = frames.find(key);
+		if (it == frames.end()){
+			it = frames.emplace(key, Surface()).first;
+			it->second.LoadFromSprite(sprite);
+		}
+
+		return &it->second;
+	}
+
+	//=========================================================================
+	// Removes all cached frames (call it after loading new pixels into
+	// the sprite).
+	//=========================================================================
+	void Clear()
+	{
+		frames.clear();
+	}
+
+private:
+	// pixels of the drawn sprite frames (frame, width, height)
+	map<tuple<int, int, int>, Surface> frames;
+};
+
+/******************************************************************************
+*
+* ConsolerExt class
+*
+******************************************************************************/
+
+class ConsolerExt : public Consoler
+{
+private:
+	// half widths of the ellipse rows (reused between calls)
+	vector<int> ellipseRows;
+
+	// outcodes of the polyline vertices (reused between calls)
+	vector<int> polylineCodes;
+
+	// polygon edge structure (rows from y1 to y2, y2 is exclusive)
+	struct Edge {
+		int y1, y2;
+		int64_t x0, y0;		// top vertex
+		int64_t dx, dy;		// direction (dy > 0)
+		int dir;			// +1 if the edge goes down, -1 if it goes up
+	};
+
+	// polygon crossing structure (first pixel right of the edge)
+	struct Crossing {
+		int x;
+		int dir;
+	};
+
+	// polygon rasterizer buffers (reused between calls)
+	vector<Edge> polygonEdges;
+	vector<Edge *> activeEdges;
+	vector<Crossing> polygonCrossings;
+	vector<Point> trianglePoints = vector<Point>(3);
+
+	// 1-bit-per-pixel stencil of the canvas (64 pixels per word)
+	vector<uint64_t> stencilBits;
+	int stencilStride = 0;			// number of words per row
+	short stencilMode = STENCIL_OFF;
+
+	// flood fill buffers (reused between calls)
+	vector<Point> floodStack;		// seeds of the spans to fill
+	vector<uint8_t> floodVisited;	// 1 for every filled pixel
+	vector<short> floodRows;		// canvas rows read so far
+	vector<uint8_t> floodRowRead;	// 1 if the row is in floodRows
+
+	// stack of clip rectangles (the top one is the active clip)
+	vector<Rect> clipStack;
+
+	// indices of the batch items that passed clipping (reused between calls)
+	vector<int> batchIndex;
+
+	// surface used as the render target (nullptr = canvas)
+	Surface *renderTarget = nullptr;
+
+	// clip stack of the canvas saved while drawing into a surface
+	vector<Rect> canvasClipStack;
+
+	// logical to physical palette applied when surfaces are drawn to the
+	// canvas
+	short palette[16] = {
+		0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+	};
+
+	// canvas layer structure
+	struct Layer {
+		Surface surface;			// layer pixels
+		int z = 0;					// z-order (higher is drawn on top)
+		int x = 0, y = 0;			// position of the layer
+		bool isStatic = false;		// rasterized only when invalidated
+		bool isValid = false;		// false if it must be rasterized
+		bool isVisible = true;		// is it visible?
+	};
+
+	// map of all layers and the same layers sorted by z-order
+	map<string, Layer> mapOfLayers;
+	vector<Layer *> vecLayers;
+
+	// bottom static layers merged into a single surface
+	Surface staticCache;
+	int staticCacheCount = 0;		// number of merged layers
+	bool isStaticCacheValid = false;
+
+	// pixels of the last sprite drawn without a cache
+	Surface spritePixels;
+
+	// row of remapped sprite or surface colors (reused between calls)
+	vector<short> remapRow;
+
+	// post-processing pass structure
+	struct PostPass {
+		short type;					// POST_COLOR, POST_SCANLINE or POST_MOSAIC
+		ColorMap colorMap;			// color ramp of the color passes
+		int param;					// scanline period or mosaic block size
+	};
+
+	// post-processing passes in registration order
+	vector<PostPass> vecPostPasses;
+
+	// screen shake offset applied by DrawPostProcessed
+	int shakeX = 0;
+	int shakeY = 0;
+
+	// row of post-processed colors (reused between calls)
+	vector<short> postRow;
+
+	// render target that was active before BeginLayer
+	Surface *layerPrevTarget = nullptr;
+
+	// types of the post-processing passes
+	enum {
+		POST_COLOR,
+		POST_SCANLINE,
+		POST_MOSAIC
+	};
+
+	// outcode bits used to reject lines outside of the clip
+	enum {
+		OUT_LEFT	= 1,
+		OUT_RIGHT	= 2,
+		OUT_TOP		= 4,
+		OUT_BOTTOM	= 8
+	};
+
+public:
+	//=========================================================================
+	// Inherits Consoler constructor.
+	//=========================================================================
+	using Consoler::Consoler;
+
+	//=========================================================================
+	// Sets the surface that all ConsolerExt drawing functions draw into.
+	// Pass nullptr to draw into the canvas again.
+	// The clip stack of the canvas is kept while a surface is the render
+	// target, but a surface always starts with an empty clip stack (clips
+	// pushed into a surface are dropped when the target changes).
+	// Sprites and bitmap texts are drawn by the Consoler library and always
+	// go to the canvas (copy them into a surface with
+	// Surface::LoadFromSprite instead).
+	//=========================================================================
+	void SetRenderTarget(Surface *surface = nullptr)
+	{
+		if (surface == renderTarget) return;
+
+		if (renderTarget == nullptr) canvasClipStack.swap(clipStack);
+		clipStack.clear();
+		if (surface == nullptr) canvasClipStack.swap(clipStack);
+
+		renderTarget = surface;
+	}
+
+	//=========================================================================
+	// Returns the current render target (nullptr = canvas).
+	//=========================================================================
+	Surface *GetRenderTarget()
+	{
+		return renderTarget;
+	}
+
+	//=========================================================================
+	// Draws a surface at XY. Transparent pixels are skipped and every run
+	// of equal colors in a row is drawn with a single fill call.
+	// Drawn into the canvas, the colors are mapped through the palette.
+	//=========================================================================
+	void DrawSurface(Surface *surface, int x, int y)
+	{
+		Rect clip = GetClip();
+
+		int j1 = max(0, clip.y1 - y);
+		int j2 = min(surface->height, clip.y2 - y);
+
+		bool isMapped = false;
+		if (renderTarget == nullptr){
+			for (int i = 0; i < 16; i++) isMapped |= (palette[i] != i);
+		}
+
+		if (!isMapped){
+			for (int j = j1; j < j2; j++)
+				DrawRow(surface->Row(j), x, y + j, surface->width, surface->transparent);
+			return;
+		}
+
+		remapRow.resize(surface->width);
+		short *dst = remapRow.data();
+
+		for (int j = j1; j < j2; j++){
+			const short *src = surface->Row(j);
+
+			// transparent pixels are tested before mapping
+			for (int i = 0; i < surface->width; i++){
+				short color = src[i];
+				short mapped = palette[color & 15];
+				bool isSkipped = (color == NONE || color == surface->transparent);
+				dst[i] = isSkipped ? (short)NONE : mapped;
+			}
+
+			DrawRow(dst, x, y + j, surface->width);
+		}
+	}
+
+	//=========================================================================
+	// Adds a new layer with the given z-order (a canvas sized surface).
+	// Static layers are rasterized once and then only when invalidated.
+	//=========================================================================
+	Surface *AddLayer(string name, int z = 0, bool isStatic = false)
+	{
+		Layer &layer = mapOfLayers[name];
+
+		layer.surface.Create(GetCanvasW(), GetCanvasH());
+		layer.z = z;
+		layer.isStatic = isStatic;
+		layer.isValid = false;
+
+		vecLayers.clear();
+		for (auto &item : mapOfLayers) vecLayers.push_back(&item.second);
+
+		stable_sort(vecLayers.begin(), vecLayers.end(),
+			[](Layer *a, Layer *b){ return a->z < b->z; }
+		);
+
+		isStaticCacheValid = false;
+		return &layer.surface;
+	}
+
+	//=========================================================================
+	// Returns the surface of a layer (nullptr if there is no such layer).
+	//=========================================================================
+	Surface *GetLayer(string name)
+	{
+		auto it = mapOfLayers.find(name);
+		return (it == mapOfLayers.end()) ? nullptr : &it->second.surface;
+	}
+
+	//=========================================================================
+	// Starts drawing into a layer and returns true if it must be redrawn.
+	// Dynamic layers are cleared and redrawn every time, static layers
+	// only after InvalidateLayer. Always close it with EndLayer:
+	//
+	//		if (BeginLayer("trees")){
+	//			...
+	//		}
+	//		EndLayer();
+	//=========================================================================
+	bool BeginLayer(string name)
+	{
+		auto it = mapOfLayers.find(name);
+		if (it == mapOfLayers.end()) return false;
+
+		Layer &layer = it->second;
+
+		layerPrevTarget = renderTarget;
+		SetRenderTarget(&layer.surface);
+
+		if (layer.isStatic && layer.isValid) return false;
+
+		layer.surface.Clear();
+		layer.isValid = true;
+
+		if (layer.isStatic) isStaticCacheValid = false;
+		return true;
+	}
+
+	//=========================================================================
+	// Stops drawing into the layer started by BeginLayer.
+	//=========================================================================
+	void EndLayer()
+	{
+		SetRenderTarget(layerPrevTarget);
+		layerPrevTarget = nullptr;
+	}
+
+	//=========================================================================
+	// Marks a static layer to be rasterized again by the next BeginLayer.
+	//=========================================================================
+	void InvalidateLayer(string name)
+	{
+		auto it = mapOfLayers.find(name);
+		if (it != mapOfLayers.end()) it->second.isValid = false;
+	}
+
+	//=========================================================================
+	// Sets the position of a layer.
+	//=========================================================================
+	void SetLayerPosition(string name, int x, int y)
+	{
+		auto it = mapOfLayers.find(name);
+		if (it == mapOfLayers.end()) return;
+
+		Layer &layer = it->second;
+
+		if (layer.x != x || layer.y != y){
+			layer.x = x;
+			layer.y = y;
+			if (layer.isStatic) isStaticCacheValid = false;
+		}
+	}
+
+	//=========================================================================
+	// Sets the visibility of a layer.
+	//=========================================================================
+	void SetLayerVisible(string name, bool bVisible)
+	{
+		auto it = mapOfLayers.find(name);
+		if (it == mapOfLayers.end()) return;
+
+		if (it->second.isVisible != bVisible){
+			it->second.isVisible = bVisible;
+			isStaticCacheValid = false;
+		}
+	}
+
+	//=========================================================================
+	// Draws all visible layers in z-order into the render target.
+	// The bottom-most static layers are merged into one cached surface,
+	// which is rebuilt only when one of them changes or moves, so
+	// unchanged static layers cost a single blit together.
+	//=========================================================================
+	void CompositeLayers()
+	{
+		// count the static layers at the bottom of the stack
+		int count = 0;
+		while (count < (int)vecLayers.size() && vecLayers[count]->isStatic)
+			count++;
+
+		if (!isStaticCacheValid || count != staticCacheCount){
+			staticCache.Create(GetCanvasW(), GetCanvasH());
+
+			for (int i = 0; i < count; i++)
+				MergeLayer(&staticCache, vecLayers[i]);
+
+			staticCacheCount = count;
+			isStaticCacheValid = true;
+		}
+
+		if (count > 0) DrawSurface(&staticCache, 0, 0);
+
+		for (int i = count; i < (int)vecLayers.size(); i++){
+			Layer *layer = vecLayers[i];
+			if (layer->isVisible)
+				DrawSurface(&layer->surface, layer->x, layer->y);
+		}
+	}
+
+	//=========================================================================
+	// Maps a logical color to a physical console color.
+	// The palette applies only to surfaces drawn into the canvas (with
+	// DrawSurface, CompositeLayers or DrawPostProcessed). Surfaces and
+	// layers keep logical colors, so palette cycling and fades show up at
+	// the next composite without redrawing (static layers stay cached).
+	// Everything drawn directly into the canvas uses physical colors and
+	// is never remapped, and GetPixelColor reads physical colors back.
+	//=========================================================================
+	void SetPaletteColor(short logical, short physical)
+	{
+		if (logical >= 0 && logical < 16) palette[logical] = physical & 15;
+	}
+
+	//=========================================================================
+	// Sets the whole palette at once.
+	//=========================================================================
+	void SetPalette(const short colors[16])
+	{
+		for (int i = 0; i < 16; i++) palette[i] = colors[i] & 15;
+	}
+
+	//=========================================================================
+	// Restores the identity palette.
+	//=========================================================================
+	void ResetPalette()
+	{
+		for (int i = 0; i < 16; i++) palette[i] = i;
+	}
+
+	//=========================================================================
+	// Returns the physical color of a logical color.
+	//=========================================================================
+	short GetPaletteColor(short logical)
+	{
+		return (logical >= 0 && logical < 16) ? palette[logical] : logical;
+	}
+
+	//=========================================================================
+	// Rotates the palette entries from first to last (inclusive) by the
+	// given number of steps (for water, fire and blinking lights).
+	//=========================================================================
+	void RotatePalette(short first, short last, int steps = 1)
+	{
+		first = max<short>(first, 0);
+		last = min<short>(last, 15);
+		if (first >= last) return;
+
+		int n = last - first + 1;
+		steps = ((steps % n) + n) % n;
+
+		rotate(palette + first, palette + first + n - steps, palette + last + 1);
+	}
+
+	//=========================================================================
+	// Draws a sprite with all its colors remapped through the color map
+	// (palette swaps, team colors, damage flashes, darkening...).
+	// (Consoler::DrawSprite overloads are still available)
+	//=========================================================================
+	using Consoler::DrawSprite;
+
+	void DrawSprite(Sprite *sprite, const ColorMap &colorMap)
+	{
+		DrawSprite(sprite, sprite->x, sprite->y, colorMap);
+	}
+
+	//=========================================================================
+	// Draws a sprite at the given XY coordinate with all its colors
+	// remapped through the color map.
+	// The pixels are read from the sprite on every call. Draw it through
+	// a SpriteCache to read every frame only once.
+	//=========================================================================
+	void DrawSprite(Sprite *sprite, float x, float y, const ColorMap &colorMap)
+	{
+		if (!sprite->isVisible) return;
+
+		spritePixels.LoadFromSprite(sprite);
+		DrawRemapped(&spritePixels, x, y, colorMap);
+	}
+
+	//=========================================================================
+	// Draws the sprite of a cache with all its colors remapped through
+	// the color map, reading every sprite frame only once:
+	//
+	//		SpriteCache *cacheBird = new SpriteCache(sprBird);
+	//		...
+	//		DrawSprite(cacheBird, ColorMap::Darken(1));
+	//=========================================================================
+	void DrawSprite(SpriteCache *cache, const ColorMap &colorMap)
+	{
+		DrawSprite(cache, cache->sprite->x, cache->sprite->y, colorMap);
+	}
+
+	//=========================================================================
+	// Draws the sprite of a cache at the given XY coordinate with all its
+	// colors remapped through the color map.
+	//=========================================================================
+	void DrawSprite(
+		SpriteCache *cache, float x, float y, const ColorMap &colorMap
+	){
+		if (!cache->sprite->isVisible) return;
+
+		DrawRemapped(cache->GetFrame(), x, y, colorMap);
+	}
+
+	//=========================================================================
+	// Adds a post-processing pass that maps all colors through a color
+	// ramp (fades via ColorMap::Darken, light ramps, color grading...).
+	//=========================================================================
+	void AddColorPass(const ColorMap &colorMap)
+	{
+		vecPostPasses.push_back({POST_COLOR, colorMap, 0});
+	}
+
+	//=========================================================================
+	// Adds a post-processing pass that maps the colors of every period-th
+	// row through a color ramp (scanline dimming).
+	//=========================================================================
+	void AddScanlinePass(const ColorMap &colorMap, int period = 2)
+	{
+		vecPostPasses.push_back({POST_SCANLINE, colorMap, max(period, 1)});
+	}
+
+	//=========================================================================
+	// Adds a post-processing pass that pixelates the frame into square
+	// blocks of the given size.
+	//=========================================================================
+	void AddMosaicPass(int blockSize)
+	{
+		vecPostPasses.push_back({POST_MOSAIC, ColorMap(), max(blockSize, 1)});
+	}
+
+	//=========================================================================
+	// Removes all post-processing passes and resets the screen shake.
+	//=========================================================================
+	void ClearPostPasses()
+	{
+		vecPostPasses.clear();
+		shakeX = shakeY = 0;
+	}
+
+	//=========================================================================
+	// Sets the screen shake offset applied by DrawPostProcessed.
+	//=========================================================================
+	void SetScreenShake(int dx, int dy)
+	{
+		shakeX = dx;
+		shakeY = dy;
+	}
+
+	//=========================================================================
+	// Draws a frame surface at XY through all post-processing passes.
+	// The passes are fused: all color ramps that apply to a row are
+	// combined into one 16-entry table, so the frame is traversed only
+	// once no matter how many passes are active. Render the scene into
+	// the frame first, e.g. with SetRenderTarget and CompositeLayers.
+	//=========================================================================
+	void DrawPostProcessed(Surface *frame, int x = 0, int y = 0)
+	{
+		int block = 1;
+		for (const PostPass &pass : vecPostPasses){
+			if (pass.type == POST_MOSAIC) block = max(block, pass.param);
+		}
+
+		postRow.resize(frame->width);
+		short *dst = postRow.data();
+
+		x += shakeX;
+		y += shakeY;
+
+		Rect clip = GetClip();
+		int j1 = max(0, clip.y1 - y);
+		int j2 = min(frame->height, clip.y2 - y);
+
+		for (int j = j1; j < j2; j++){
+			// combine the color ramps of this row in registration order
+			short lut[16];
+			for (int i = 0; i < 16; i++) lut[i] = i;
+
+			for (const PostPass &pass : vecPostPasses){
+				if (pass.type == POST_COLOR ||
+					(pass.type == POST_SCANLINE && j % pass.param == 0)
+				){
+					for (int i = 0; i < 16; i++){
+						if (lut[i] != NONE) lut[i] = pass.colorMap.colors[lut[i] & 15];
+					}
+				}
+			}
+
+			// the palette maps the result when drawing into the canvas
+			if (renderTarget == nullptr){
+				for (int i = 0; i < 16; i++){
+					if (lut[i] != NONE) lut[i] = palette[lut[i] & 15];
+				}
+			}
+
+			const short *src = frame->Row(j - j % block);
+			short transparent = frame->transparent;
+
+			// transparent pixels are tested before mapping, so a ramp can
+			// never turn them into a visible color (or a visible color
+			// into the transparent one)
+			if (block == 1){
+				for (int i = 0; i < frame->width; i++){
+					short color = src[i];
+					short mapped = lut[color & 15];
+					bool isSkipped = (color == NONE || color == transparent);
+					dst[i] = isSkipped ? (short)NONE : mapped;
+				}
+			} else {
+				for (int i = 0; i < frame->width; i++){
+					short color = src[i - i % block];
+					short mapped = lut[color & 15];
+					bool isSkipped = (color == NONE || color == transparent);
+					dst[i] = isSkipped ? (short)NONE : mapped;
+				}
+			}
+
+			DrawRow(dst, x, y + j, frame->width);
+		}
+	}
+
+	//=========================================================================
+	// Gets the pixel color (0 to 15) of the render target, or NONE if XY is
+	// outside of it. Canvas cells are spaces, so the visible color is the
+	// background nibble of their attributes (black after ClearScreen2).
+	// (hides Consoler::GetPixelColor)
+	//=========================================================================
+	short GetPixelColor(int x, int y)
+	{
+		if (renderTarget) return renderTarget->GetPixelColor(x, y);
+
+		if (x < 0 || y < 0 || x >= GetCanvasW() || y >= GetCanvasH())
+			return NONE;
+
+		return (Consoler::GetPixelColor(x, y) >> 4) & 15;
+	}
+
+	//=========================================================================
+	// Pushes a new clip rectangle at XY using its width and height.
+	// The new clip is intersected with the current one, so nested panels
+	// never draw outside of their parents.
+	//=========================================================================
+	void PushClip(int x, int y, int width, int height)
+	{
+		Rect curr = GetClip();
+		Rect clip;
+
+		clip.x1 = max(x, curr.x1);
+		clip.y1 = max(y, curr.y1);
+		clip.x2 = max(clip.x1, min(x + width, curr.x2));
+		clip.y2 = max(clip.y1, min(y + height, curr.y2));
+		clip.cx = (clip.x1 + clip.x2) / 2;
+		clip.cy = (clip.y1 + clip.y2) / 2;
+
+		clipStack.push_back(clip);
+	}
+
+	//=========================================================================
+	// Pops the current clip rectangle and restores the previous one.
+	//=========================================================================
+	void PopClip()
+	{
+		if (!clipStack.empty()) clipStack.pop_back();
+	}
+
+	//=========================================================================
+	// Returns the active clip rectangle (x2 and y2 are exclusive,
+	// unlike the inclusive Rect of sprite bounds and DrawRects).
+	// If no clip is pushed, the whole render target is returned.
+	//=========================================================================
+	Rect GetClip()
+	{
+		if (!clipStack.empty()) return clipStack.back();
+
+		Rect clip;
+		clip.x2 = renderTarget ? renderTarget->width : GetCanvasW();
+		clip.y2 = renderTarget ? renderTarget->height : GetCanvasH();
+		clip.cx = clip.x2 / 2;
+		clip.cy = clip.y2 / 2;
+
+		return clip;
+	}
+
+	//=========================================================================
+	// Draws a pixel inside the active clip.
+	// (hides Consoler::DrawPixel)
+	//=========================================================================
+	void DrawPixel(int x, int y, short color)
+	{
+		Rect clip = GetClip();
+
+		if (color != NONE &&
+			x >= clip.x1 && x < clip.x2 && y >= clip.y1 && y < clip.y2
+		) WritePixel(x, y, color);
+	}
+
+	//=========================================================================
+	// Draws a rectangle at XY using its width and height.
+	// The rectangle is clipped once to the active clip.
+	// (hides Consoler::DrawRectangle)
+	//=========================================================================
+	void DrawRectangle(int x, int y, int width, int height, short color)
+	{
+		FillRect(x, y, x + width - 1, y + height - 1, color);
+	}
+
+	//=========================================================================
+	// Draws a rectangle using its top-left and bottom-right coords
+	// (inclusive, as in the Consoler library and sprite bounds).
+	// The rectangle is clipped once to the active clip.
+	// (hides Consoler::DrawRectangleCoord)
+	//=========================================================================
+	void DrawRectangleCoord(int x1, int y1, int x2, int y2, short color)
+	{
+		FillRect(x1, y1, x2, y2, color);
+	}
+
+	//=========================================================================
+	// Draws a bordered rectangle at XY using its width, height and stroke.
+	// The stroke lies inside the rectangle. The four border strips and the
+	// inside are separate clipped rectangles, so no pixel is drawn twice.
+	// (hides Consoler::DrawRectangleBorder)
+	//=========================================================================
+	void DrawRectangleBorder(
+		int x, int y, int width, int height,
+		short fillColor, short strokeColor, int strokeSize
+	){
+		DrawRectanglePercent(
+			x, y, width, height, fillColor, strokeColor, strokeSize
+		);
+	}
+
+	//=========================================================================
+	// Draws a bordered rectangle filled with the specified percentage
+	// (0 to 1) at position XY using its width, height and stroke.
+	// The filled part is measured from the outer edge, as in the library:
+	// horizontal bars fill the inside columns left of (int)(width * percent),
+	// vertical bars fill the inside rows from the bottom that are less than
+	// (int)(height * percent) - 1 rows above the bottom edge. The rest of
+	// the inside is left untouched. (Without a stroke, the library also
+	// fills one row below vertical bars; that row is not drawn here.)
+	// (hides Consoler::DrawRectanglePercent)
+	//=========================================================================
+	void DrawRectanglePercent(
+		int x, int y, int width, int height,
+		short fillColor, short strokeColor, int strokeSize,
+		float percent = 1, bool isHor = true
+	){
+		if (width <= 0 || height <= 0) return;
+
+		int x2 = x + width - 1;
+		int y2 = y + height - 1;
+		int s = max(strokeSize, 0);
+
+		// the stroke covers the whole rectangle
+		if (2 * s >= width || 2 * s >= height){
+			FillRect(x, y, x2, y2, (s > 0) ? strokeColor : fillColor);
+			return;
+		}
+
+		if (s > 0){
+			FillRect(x, y, x2, y + s - 1, strokeColor);
+			FillRect(x, y2 - s + 1, x2, y2, strokeColor);
+			FillRect(x, y + s, x + s - 1, y2 - s, strokeColor);
+			FillRect(x2 - s + 1, y + s, x2, y2 - s, strokeColor);
+		}
+
+		percent = min(max(percent, 0.0f), 1.0f);
+
+		if (isHor){
+			int fill = min((int)(width * percent), width - s);
+			FillRect(x + s, y + s, x + fill - 1, y2 - s, fillColor);
+		} else {
+			int fill = min((int)(height * percent), height - s);
+			FillRect(x + s, y2 - fill + 2, x2 - s, y2 - s, fillColor);
+		}
+	}
+
+	//=========================================================================
+	// Fills a rectangle from (x1, y1) to (x2, y2) (inclusive).
+	// The rectangle is clipped to the active clip before drawing.
+	//=========================================================================
+	void FillRect(int x1, int y1, int x2, int y2, short color)
+	{
+		if (color == NONE) return;
+
+		Rect clip = GetClip();
+
+		x1 = max(x1, clip.x1);
+		y1 = max(y1, clip.y1);
+		x2 = min(x2, clip.x2 - 1);
+		y2 = min(y2, clip.y2 - 1);
+
+		if (x1 <= x2 && y1 <= y2)
+			WriteRect(x1, y1, x2 - x1 + 1, y2 - y1 + 1, color);
+	}
+
+	//=========================================================================
+	// Fills a horizontal span of pixels from x1 to x2 (inclusive) in row y.
+	// The span is clipped to the active clip before drawing.
+	//=========================================================================
+	void FillSpan(int x1, int x2, int y, short color)
+	{
+		if (x1 > x2) swap(x1, x2);
+		FillRect(x1, y, x2, y, color);
+	}
+
+	//=========================================================================
+	// Fills a vertical span of pixels from y1 to y2 (inclusive) in column x.
+	// The span is clipped to the active clip before drawing.
+	//=========================================================================
+	void FillColumn(int x, int y1, int y2, short color)
+	{
+		if (y1 > y2) swap(y1, y2);
+		FillRect(x, y1, x, y2, color);
+	}
+
+	//=========================================================================
+	// Draws a line using the integer Bresenham algorithm.
+	// The line is clipped to the active clip once, by advancing the
+	// Bresenham error term to the clip edges, and then drawn as horizontal
+	// or vertical runs of pixels. A clipped line has exactly the same
+	// pixels as the unclipped one.
+	// (hides Consoler::DrawLine)
+	//=========================================================================
+	void DrawLine(int x1, int y1, int x2, int y2, short color)
+	{
+		Point p1 = {x1, y1};
+		Point p2 = {x2, y2};
+
+		DrawClippedLine(p1, p2, color, GetClip());
+	}
+
+	//=========================================================================
+	// Draws connected lines through all the given points.
+	// Set isClosed to connect the last point with the first one.
+	//=========================================================================
+	void DrawPolyline(
+		const vector<Point> &points, short color, bool isClosed = false
+	){
+		int count = points.size();
+		if (color == NONE || count == 0) return;
+
+		// every vertex is shared by two segments, so calculate its
+		// outcode only once
+		Rect clip = GetClip();
+		polylineCodes.resize(count);
+		for (int i = 0; i < count; i++)
+			polylineCodes[i] = OutCode(points[i].x, points[i].y, clip);
+
+		int segments = isClosed ? count : count - 1;
+
+		for (int i = 0; i < segments; i++){
+			int j = (i + 1) % count;
+
+			if ((polylineCodes[i] & polylineCodes[j]) == 0){
+				RasterLine(
+					points[i].x, points[i].y, points[j].x, points[j].y,
+					color, clip
+				);
+			}
+		}
+
+		// a single point is drawn as a pixel
+		if (count == 1) FillSpan(points[0].x, points[0].x, points[0].y, color);
+	}
+
+	//=========================================================================
+	// Draws an array of pixels, each one in its own color.
+	// All points are clipped in one pass before any pixel is drawn.
+	//=========================================================================
+	void DrawPixels(const Point *points, int count, const short *colors)
+	{
+		int n = ClipPoints(points, count);
+
+		for (int i = 0; i < n; i++){
+			int k = batchIndex[i];
+			if (colors[k] != NONE)
+				WritePixel(points[k].x, points[k].y, colors[k]);
+		}
+	}
+
+	//=========================================================================
+	// Draws an array of pixels in the same color.
+	//=========================================================================
+	void DrawPixels(const Point *points, int count, short color)
+	{
+		if (color == NONE) return;
+
+		int n = ClipPoints(points, count);
+
+		for (int i = 0; i < n; i++){
+			const Point &p = points[batchIndex[i]];
+			WritePixel(p.x, p.y, color);
+		}
+	}
+
+	//=========================================================================
+	// Draws an array of lines, each one in its own color.
+	// Line i goes from points[2*i] to points[2*i+1].
+	//=========================================================================
+	void DrawLines(const Point *points, int count, const short *colors)
+	{
+		Rect clip = GetClip();
+
+		for (int i = 0; i < count; i++)
+			DrawClippedLine(points[2 * i], points[2 * i + 1], colors[i], clip);
+	}
+
+	//=========================================================================
+	// Draws an array of lines in the same color.
+	// Line i goes from points[2*i] to points[2*i+1].
+	//=========================================================================
+	void DrawLines(const Point *points, int count, short color)
+	{
+		Rect clip = GetClip();
+
+		for (int i = 0; i < count; i++)
+			DrawClippedLine(points[2 * i], points[2 * i + 1], color, clip);
+	}
+
+	//=========================================================================
+	// Draws an array of filled rectangles, each one in its own color.
+	// Rectangles use top-left (x1, y1) and bottom-right (x2, y2) coords,
+	// both inclusive (as in DrawRectangleCoord and Sprite::GetBound).
+	//=========================================================================
+	void DrawRects(const Rect *rects, int count, const short *colors)
+	{
+		Rect clip = GetClip();
+
+		for (int i = 0; i < count; i++)
+			DrawClippedRect(rects[i], colors[i], clip);
+	}
+
+	//=========================================================================
+	// Draws an array of filled rectangles in the same color.
+	//=========================================================================
+	void DrawRects(const Rect *rects, int count, short color)
+	{
+		Rect clip = GetClip();
+
+		for (int i = 0; i < count; i++)
+			DrawClippedRect(rects[i], color, clip);
+	}
+
+	//=========================================================================
+	// Replays all draw calls recorded in the command buffer, optionally
+	// translated by (dx, dy).
+	// If the whole translated buffer lies inside the active clip, the
+	// shapes are drawn without clipping them again.
+	//=========================================================================
+	void DrawCommandBuffer(CommandBuffer *buffer, int dx = 0, int dy = 0)
+	{
+		Rect clip = GetClip();
+		const Rect &bound = buffer->bound;
+
+		bool isInside =
+			bound.x1 + dx >= clip.x1 && bound.x2 + dx <= clip.x2 &&
+			bound.y1 + dy >= clip.y1 && bound.y2 + dy <= clip.y2;
+
+		for (const CommandBuffer::Command &cmd : buffer->commands){
+			int a = cmd.a + dx;
+			int b = cmd.b + dy;
+
+			switch (cmd.type){
+				case CommandBuffer::CMD_PIXEL:
+					if (isInside){
+						if (cmd.color1 != NONE)
+							WritePixel(a, b, cmd.color1);
+					} else {
+						DrawPixel(a, b, cmd.color1);
+					}
+					break;
+
+				case CommandBuffer::CMD_LINE:
+					if (isInside){
+						if (cmd.color1 != NONE)
+							RasterLine(a, b, cmd.c + dx, cmd.d + dy, cmd.color1, clip);
+					} else {
+						DrawLine(a, b, cmd.c + dx, cmd.d + dy, cmd.color1);
+					}
+					break;
+
+				case CommandBuffer::CMD_RECT:
+					if (isInside){
+						if (cmd.color1 != NONE)
+							WriteRect(a, b, cmd.c, cmd.d, cmd.color1);
+					} else {
+						DrawRectangle(a, b, cmd.c, cmd.d, cmd.color1);
+					}
+					break;
+
+				case CommandBuffer::CMD_ELLIPSE:
+					DrawEllipse(a, b, cmd.c, cmd.d, cmd.color1, cmd.color2);
+					break;
+
+				case CommandBuffer::CMD_SPRITE:
+					Consoler::DrawSprite(cmd.sprite, a, b, cmd.color1);
+					break;
+
+				case CommandBuffer::CMD_TEXT:
+					Consoler::DrawBitmapText(
+						buffer->texts[cmd.text], a, b,
+						cmd.align, cmd.color1, cmd.color2
+					);
+					break;
+			}
+		}
+	}
+
+	//=========================================================================
+	// Locks the rows from y1 to y2 (exclusive) of the surface render target
+	// for direct access. Returns the row pointers with their stride, so
+	// procedural effects can run as tight loops over plain short arrays.
+	// The rows are the surface pixels themselves, so nothing has to be
+	// unlocked or written back.
+	//
+	// The canvas lives inside the Consoler library and cannot be accessed
+	// directly, so if the canvas is the render target an empty lock (no
+	// rows) is returned. Render the effect into a surface and draw it with
+	// DrawSurface instead:
+	//
+	//		SetRenderTarget(&plasma);
+	//		CanvasLock lock = LockCanvas();
+	//		for (int y = lock.y1; y < lock.y2; y++){
+	//			short *row = lock.Row(y);
+	//			...
+	//		}
+	//		SetRenderTarget();
+	//		DrawSurface(&plasma, 0, 0);
+	//=========================================================================
+	CanvasLock LockCanvas(int y1 = 0, int y2 = NONE)
+	{
+		CanvasLock lock;
+		if (renderTarget == nullptr) return lock;
+
+		int h = renderTarget->height;
+
+		if (y2 == NONE) y2 = h;
+		y1 = max(y1, 0);
+		y2 = max(y1, min(y2, h));
+
+		lock.pixels = renderTarget->pixels.data();
+		lock.stride = renderTarget->width;
+		lock.y1 = y1;
+		lock.y2 = y2;
+
+		return lock;
+	}
+
+	//=========================================================================
+	// Draws a filled triangle with an optional stroke.
+	//=========================================================================
+	void DrawTriangle(
+		int x1, int y1, int x2, int y2, int x3, int y3,
+		short fillColor, short strokeColor = NONE
+	){
+		trianglePoints[0] = {x1, y1};
+		trianglePoints[1] = {x2, y2};
+		trianglePoints[2] = {x3, y3};
+
+		DrawPolygon(trianglePoints, fillColor, strokeColor);
+	}
+
+	//=========================================================================
+	// Draws a filled polygon (convex or concave) with an optional stroke.
+	// Uses an integer scanline rasterizer with an active edge table:
+	// pixel centers are sampled, so adjacent polygons that share an edge
+	// never overlap and never leave gaps. fillRule is EVEN_ODD or NON_ZERO.
+	//=========================================================================
+	void DrawPolygon(
+		const vector<Point> &points, short fillColor,
+		short strokeColor = NONE, short fillRule = EVEN_ODD
+	){
+		int count = points.size();
+
+		if (fillColor != NONE && count >= 3)
+			FillPolygon(points, fillColor, fillRule);
+
+		if (strokeColor != NONE)
+			DrawPolyline(points, strokeColor, true);
+	}
+
+	//=========================================================================
+	// Sets the stencil mode used by all ConsolerExt drawing into the canvas:
+	//		- STENCIL_OFF		draw normally
+	//		- STENCIL_WRITE		draw shapes into the stencil (set bits)
+	//		- STENCIL_ERASE		erase shapes from the stencil (clear bits)
+	//		- STENCIL_TEST		draw only where the stencil is set
+	//		- STENCIL_TEST_INV	draw only where the stencil is not set
+	// For example, draw a circle in STENCIL_WRITE mode and then the scene
+	// in STENCIL_TEST mode to get a spotlight.
+	//=========================================================================
+	void SetStencilMode(short mode)
+	{
+		if (mode != STENCIL_OFF && stencilBits.empty()) ClearStencil();
+		stencilMode = mode;
+	}
+
+	//=========================================================================
+	// Returns the current stencil mode.
+	//=========================================================================
+	short GetStencilMode()
+	{
+		return stencilMode;
+	}
+
+	//=========================================================================
+	// Sets all stencil bits to the given value.
+	//=========================================================================
+	void ClearStencil(bool value = false)
+	{
+		stencilStride = (GetCanvasW() + 63) / 64;
+		stencilBits.assign(stencilStride * GetCanvasH(), value ? ~0ULL : 0);
+	}
+
+	//=========================================================================
+	// Returns the stencil bit of a pixel.
+	//=========================================================================
+	bool GetStencil(int x, int y)
+	{
+		if (stencilBits.empty() || x < 0 || y < 0 ||
+			x >= GetCanvasW() || y >= GetCanvasH()
+		) return false;
+
+		return (stencilBits[y * stencilStride + (x >> 6)] >> (x & 63)) & 1;
+	}
+
+	//=========================================================================
+	// Fills the 4-connected area that has the same color as the pixel at
+	// (x, y) with the given color (paint bucket).
+	// Uses a scanline fill with an explicit stack, so it never overflows
+	// the call stack, and every filled span costs a single fill call.
+	// The fill never leaves the active clip.
+	//=========================================================================
+	void FloodFill(int x, int y, short color)
+	{
+		if (color == NONE) return;
+
+		// filling with the same color would change nothing
+		// (GetPixelColor returns the visible color of canvas pixels)
+		if (color == GetPixelColor(x, y)) return;
+
+		ScanFill(x, y, color);
+	}
+
+	//=========================================================================
+	// Calculates the area FloodFill would fill, without drawing it.
+	// The mask is resized to the render target size (row by row) and
+	// contains 1 for every pixel of the area and 0 elsewhere.
+	//=========================================================================
+	void FloodFillMask(int x, int y, vector<uint8_t> *mask)
+	{
+		ScanFill(x, y, NONE);
+		*mask = floodVisited;
+	}
+
+	//=========================================================================
+	// Draws a circle using horizontal spans.
+	// (hides Consoler::DrawCircle, see DrawEllipse)
+	//=========================================================================
+	void DrawCircle(
+		int cx, int cy, int radius,
+		short strokeColor, short fillColor = NONE
+	){
+		DrawEllipse(cx, cy, radius, radius, strokeColor, fillColor);
+	}
+
+	//=========================================================================
+	// Draws an ellipse with the center at (cx, cy) and radii rx and ry.
+	// Uses the integer midpoint test x^2/(rx+1/2)^2 + y^2/(ry+1/2)^2 <= 1,
+	// so every row is drawn as one fill span and at most two stroke spans.
+	//=========================================================================
+	void DrawEllipse(
+		int cx, int cy, int rx, int ry,
+		short strokeColor, short fillColor = NONE
+	){
+		if (rx < 0 || ry < 0) return;
+
+		// skip ellipses that are completely outside of the clip
+		Rect clip = GetClip();
+		if (cx + rx < clip.x1 || cx - rx >= clip.x2 ||
+			cy + ry < clip.y1 || cy - ry >= clip.y2
+		) return;
+
+		CalcEllipseRows(rx, ry);
+
+		for (int dy = 0; dy <= ry; dy++){
+			int outer = ellipseRows[dy];
+
+			// the part of the row covered by the next (narrower) row is
+			// the interior, the rest of the row is the stroke
+			int inner = (dy < ry) ? min(ellipseRows[dy + 1], outer - 1) : -1;
+
+			for (int side = 0; side < (dy == 0 ? 1 : 2); side++){
+				int y = (side == 0) ? cy + dy : cy - dy;
+
+				if (strokeColor == NONE){
+					FillSpan(cx - outer, cx + outer, y, fillColor);
+
+				} else if (inner < 0 || strokeColor == fillColor){
+					FillSpan(cx - outer, cx + outer, y, strokeColor);
+
+				} else {
+					FillSpan(cx - outer, cx - inner - 1, y, strokeColor);
+					FillSpan(cx - inner, cx + inner, y, fillColor);
+					FillSpan(cx + inner + 1, cx + outer, y, strokeColor);
+				}
+			}
+		}
+	}
+
+	//=========================================================================
+	// Draws the outline of an elliptic arc from startAngle to endAngle.
+	// Angles are in degrees, measured clockwise from the positive X axis.
+	//=========================================================================
+	void DrawArc(
+		int cx, int cy, int rx, int ry,
+		float startAngle, float endAngle, short color
+	){
+		if (rx < 0 || ry < 0 || color == NONE) return;
+
+		float sweep = endAngle - startAngle;
+
+		if (sweep >= 360 || sweep <= -360){
+			DrawEllipse(cx, cy, rx, ry, color);
+			return;
+		}
+
+		if (sweep < 0){
+			swap(startAngle, endAngle);
+			sweep = -sweep;
+		}
+
+		startAngle = fmod(startAngle, 360.0f);
+		if (startAngle < 0) startAngle += 360;
+
+		CalcEllipseRows(rx, ry);
+
+		for (int dy = -ry; dy <= ry; dy++){
+			int outer = ellipseRows[abs(dy)];
+			int inner = (abs(dy) < ry) ?
+				min(ellipseRows[abs(dy) + 1], outer - 1) : -1;
+
+			// walk the stroke pixels of this row from left to right
+			// and draw the runs that fall within the arc
+			if (inner < 0){
+				DrawArcRun(cx, cy, dy, -outer, outer, startAngle, sweep, color);
+			} else {
+				DrawArcRun(cx, cy, dy, -outer, -inner - 1, startAngle, sweep, color);
+				DrawArcRun(cx, cy, dy, inner + 1, outer, startAngle, sweep, color);
+			}
+		}
+	}
+
+private:
+	//=========================================================================
+	// Merges a visible layer into the destination surface.
+	// The inner loop is a branch-free select, so the compiler can
+	// vectorize it.
+	//=========================================================================
+	static void MergeLayer(Surface *dst, Layer *layer)
+	{
+		if (!layer->isVisible) return;
+
+		Surface &src = layer->surface;
+		short transparent = src.transparent;
+
+		int i1 = max(0, -layer->x);
+		int i2 = min(src.width, dst->width - layer->x);
+		int j1 = max(0, -layer->y);
+		int j2 = min(src.height, dst->height - layer->y);
+
+		for (int j = j1; j < j2; j++){
+			const short *s = src.Row(j);
+			short *d = dst->Row(layer->y + j) + layer->x;
+
+			for (int i = i1; i < i2; i++){
+				short color = s[i];
+				bool isOpaque = (color != NONE) & (color != transparent);
+				d[i] = isOpaque ? color : d[i];
+			}
+		}
+	}
+
+	//=========================================================================
+	// Clips an array of points against the active clip and stores the
+	// indices of the visible ones in batchIndex. Returns their number.
+	// The loop is branchless (one unsigned compare per axis), so it
+	// keeps the pipeline busy on large random point sets.
+	//=========================================================================
+	int ClipPoints(const Point *points, int count)
+	{
+		Rect clip = GetClip();
+		unsigned w = clip.x2 - clip.x1;
+		unsigned h = clip.y2 - clip.y1;
+
+		batchIndex.resize(count);
+		int *index = batchIndex.data();
+		int n = 0;
+
+		for (int i = 0; i < count; i++){
+			// subtract as unsigned, so coordinates far outside of the
+			// clip wrap around instead of overflowing
+			unsigned dx = (unsigned)points[i].x - (unsigned)clip.x1;
+			unsigned dy = (unsigned)points[i].y - (unsigned)clip.y1;
+
+			index[n] = i;
+			n += (dx < w) & (dy < h);
+		}
+
+		return n;
+	}
+
+	//=========================================================================
+	// Draws a line clipped against the given clip rectangle.
+	//=========================================================================
+	void DrawClippedLine(Point p1, Point p2, short color, const Rect &clip)
+	{
+		if (color == NONE) return;
+
+		int code1 = OutCode(p1.x, p1.y, clip);
+		int code2 = OutCode(p2.x, p2.y, clip);
+
+		if ((code1 & code2) == 0)
+			RasterLine(p1.x, p1.y, p2.x, p2.y, color, clip);
+	}
+
+	//=========================================================================
+	// Draws a filled rectangle clipped against the given clip rectangle
+	// (rect corners are inclusive, clip x2 and y2 are exclusive).
+	//=========================================================================
+	void DrawClippedRect(const Rect &rect, short color, const Rect &clip)
+	{
+		int x1 = max(rect.x1, clip.x1);
+		int y1 = max(rect.y1, clip.y1);
+		int x2 = min(rect.x2 + 1, clip.x2);
+		int y2 = min(rect.y2 + 1, clip.y2);
+
+		if (color != NONE && x1 < x2 && y1 < y2)
+			WriteRect(x1, y1, x2 - x1, y2 - y1, color);
+	}
+
+	//=========================================================================
+	// Draws the pixels of a sprite frame at XY with all colors remapped
+	// through the color map.
+	//=========================================================================
+	void DrawRemapped(
+		Surface *pixels, float x, float y, const ColorMap &colorMap
+	){
+		Rect clip = GetClip();
+
+		int px = (int)x;
+		int py = (int)y;
+		int j1 = max(0, clip.y1 - py);
+		int j2 = min(pixels->height, clip.y2 - py);
+
+		remapRow.resize(pixels->width);
+		short *dst = remapRow.data();
+
+		for (int j = j1; j < j2; j++){
+			const short *src = pixels->Row(j);
+
+			// table lookup without branches (NONE stays NONE)
+			for (int i = 0; i < pixels->width; i++){
+				short color = src[i];
+				short mapped = colorMap.colors[color & 15];
+				dst[i] = (color == NONE) ? color : mapped;
+			}
+
+			DrawRow(dst, px, py + j, pixels->width);
+		}
+	}
+
+	//=========================================================================
+	// Draws a row of pixel colors at XY as runs of equal colors.
+	// The row is clipped once and NONE (or transparent) pixels are skipped.
+	//=========================================================================
+	void DrawRow(
+		const short *pixels, int x, int y, int width, short transparent = NONE
+	){
+		Rect clip = GetClip();
+		if (y < clip.y1 || y >= clip.y2) return;
+
+		int i1 = max(0, clip.x1 - x);
+		int i2 = min(width, clip.x2 - x);
+
+		for (int i = i1; i < i2; ){
+			short color = pixels[i];
+			int start = i;
+
+			while (++i < i2 && pixels[i] == color);
+
+			if (color != NONE && color != transparent)
+				WriteRect(x + start, y, i - start, 1, color);
+		}
+	}
+
+	//=========================================================================
+	// Writes an already clipped rectangle to the render target.
+	//=========================================================================
+	void WriteRect(int x, int y, int width, int height, short color)
+	{
+		if (renderTarget == nullptr){
+			if (stencilMode == STENCIL_OFF){
+				Consoler::DrawRectangle(x, y, width, height, color);
+			} else {
+				for (int j = y; j < y + height; j++)
+					WriteStencilSpan(x, x + width, j, color);
+			}
+			return;
+		}
+
+		for (int j = y; j < y + height; j++){
+			short *row = renderTarget->Row(j) + x;
+			fill(row, row + width, color);
+		}
+	}
+
+	//=========================================================================
+	// Writes an already clipped pixel to the render target.
+	//=========================================================================
+	void WritePixel(int x, int y, short color)
+	{
+		if (renderTarget == nullptr){
+			if (stencilMode == STENCIL_OFF){
+				Consoler::DrawPixel(x, y, color);
+			} else {
+				WriteStencilSpan(x, x + 1, y, color);
+			}
+			return;
+		}
+
+		renderTarget->Row(y)[x] = color;
+	}
+
+	//=========================================================================
+	// Writes the canvas span from x1 to x2 (exclusive) in row y through
+	// the stencil. The stencil is processed 64 pixels at a time: full and
+	// empty words are handled with a single test, mixed words are split
+	// into runs with bit scans.
+	//=========================================================================
+	void WriteStencilSpan(int x1, int x2, int y, short color)
+	{
+		uint64_t *words = &stencilBits[y * stencilStride];
+		int w1 = x1 >> 6;
+		int w2 = (x2 - 1) >> 6;
+
+		// pending run, merged across word boundaries
+		int runStart = 0, runEnd = 0;
+
+		for (int k = w1; k <= w2; k++){
+			// bits of this word covered by the span
+			uint64_t mask = ~0ULL;
+			if (k == w1) mask &= ~0ULL << (x1 & 63);
+			if (k == w2 && (x2 & 63)) mask &= ~0ULL >> (64 - (x2 & 63));
+
+			if (stencilMode == STENCIL_WRITE){
+				words[k] |= mask;
+				continue;
+			}
+			if (stencilMode == STENCIL_ERASE){
+				words[k] &= ~mask;
+				continue;
+			}
+
+			uint64_t bits = (stencilMode == STENCIL_TEST) ? words[k] : ~words[k];
+			bits &= mask;
+
+			// draw the runs of set bits
+			while (bits){
+				int start = __builtin_ctzll(bits);
+				uint64_t rest = ~(bits >> start);
+				int len = rest ? __builtin_ctzll(rest) : 64 - start;
+
+				if (k * 64 + start != runEnd){
+					if (runEnd > runStart)
+						Consoler::DrawRectangle(runStart, y, runEnd - runStart, 1, color);
+					runStart = k * 64 + start;
+				}
+				runEnd = k * 64 + start + len;
+
+				bits = (start + len < 64) ? bits & (~0ULL << (start + len)) : 0;
+			}
+		}
+
+		if (runEnd > runStart)
+			Consoler::DrawRectangle(runStart, y, runEnd - runStart, 1, color);
+	}
+
+	//=========================================================================
+	// Returns the outcode of a point against the clip (lines whose end
+	// points share an outcode bit are completely outside of the clip).
+	//=========================================================================
+	int OutCode(int x, int y, const Rect &clip)
+	{
+		int code = 0;
+
+		if (x < clip.x1) code |= OUT_LEFT;
+		else if (x >= clip.x2) code |= OUT_RIGHT;
+
+		if (y < clip.y1) code |= OUT_TOP;
+		else if (y >= clip.y2) code |= OUT_BOTTOM;
+
+		return code;
+	}
+
+	//=========================================================================
+	// Fills a polygon using the active edge table.
+	//=========================================================================
+	void FillPolygon(const vector<Point> &points, short color, short fillRule)
+	{
+		Rect clip = GetClip();
+		int count = points.size();
+
+		// build the edge table (horizontal edges are skipped)
+		polygonEdges.clear();
+
+		for (int i = 0; i < count; i++){
+			const Point &a = points[i];
+			const Point &b = points[(i + 1) % count];
+
+			if (a.y == b.y) continue;
+
+			const Point &top = (a.y < b.y) ? a : b;
+			const Point &bot = (a.y < b.y) ? b : a;
+
+			int y1 = max(top.y, clip.y1);
+			int y2 = min(bot.y, clip.y2);
+			if (y1 >= y2) continue;
+
+			polygonEdges.push_back({
+				y1, y2, top.x, top.y,
+				(int64_t)bot.x - top.x, (int64_t)bot.y - top.y,
+				(a.y < b.y) ? 1 : -1
+			});
+		}
+
+		if (polygonEdges.empty()) return;
+
+		sort(polygonEdges.begin(), polygonEdges.end(),
+			[](const Edge &a, const Edge &b){ return a.y1 < b.y1; }
+		);
+
+		activeEdges.clear();
+		size_t next = 0;
+
+		for (int y = polygonEdges[0].y1; y < clip.y2; y++){
+			// add the edges starting in this row, remove the finished ones
+			while (next < polygonEdges.size() && polygonEdges[next].y1 == y)
+				activeEdges.push_back(&polygonEdges[next++]);
+
+			activeEdges.erase(
+				remove_if(activeEdges.begin(), activeEdges.end(),
+					[y](Edge *e){ return e->y2 <= y; }),
+				activeEdges.end()
+			);
+
+			if (activeEdges.empty()){
+				if (next == polygonEdges.size()) break;
+				continue;
+			}
+
+			// the first pixel whose center (i + 1/2) is at or right of the
+			// edge at the row center (y + 1/2), in exact integer math
+			polygonCrossings.clear();
+
+			for (Edge *e : activeEdges){
+				int64_t den = 2 * e->dy;
+				int64_t num = e->x0 * den + (2 * (y - e->y0) + 1) * e->dx;
+
+				polygonCrossings.push_back({
+					(int)CeilDiv(2 * num - den, 2 * den), e->dir
+				});
+			}
+
+			sort(polygonCrossings.begin(), polygonCrossings.end(),
+				[](const Crossing &a, const Crossing &b){ return a.x < b.x; }
+			);
+
+			// fill the spans between the crossings
+			int winding = 0;
+
+			for (size_t i = 0; i + 1 < polygonCrossings.size(); i++){
+				winding += (fillRule == EVEN_ODD) ? 1 : polygonCrossings[i].dir;
+
+				bool isInside = (fillRule == EVEN_ODD) ?
+					(winding & 1) : (winding != 0);
+
+				int x1 = polygonCrossings[i].x;
+				int x2 = polygonCrossings[i + 1].x - 1;
+
+				if (isInside && x1 <= x2) FillSpan(x1, x2, y, color);
+			}
+		}
+	}
+
+	//=========================================================================
+	// Scanline flood fill from (x, y). Spans are drawn in the given color
+	// (nothing is drawn if it is NONE) and marked in floodVisited.
+	//=========================================================================
+	void ScanFill(int x, int y, short color)
+	{
+		int w = renderTarget ? renderTarget->width : GetCanvasW();
+		int h = renderTarget ? renderTarget->height : GetCanvasH();
+
+		floodVisited.assign(w * h, 0);
+
+		if (renderTarget == nullptr){
+			floodRows.resize(w * h);
+			floodRowRead.assign(h, 0);
+		}
+
+		Rect clip = GetClip();
+		if (x < clip.x1 || x >= clip.x2 || y < clip.y1 || y >= clip.y2) return;
+
+		short target = FloodRow(y, w)[x];
+
+		floodStack.clear();
+		floodStack.push_back({x, y});
+
+		while (!floodStack.empty()){
+			Point seed = floodStack.back();
+			floodStack.pop_back();
+
+			const short *row = FloodRow(seed.y, w);
+			uint8_t *visited = &floodVisited[seed.y * w];
+
+			if (visited[seed.x]) continue;
+
+			// expand the span to the left and right
+			int x1 = seed.x, x2 = seed.x;
+			while (x1 > clip.x1 && row[x1 - 1] == target && !visited[x1 - 1]) x1--;
+			while (x2 < clip.x2 - 1 && row[x2 + 1] == target && !visited[x2 + 1]) x2++;
+
+			fill(visited + x1, visited + x2 + 1, 1);
+			if (color != NONE) FillSpan(x1, x2, seed.y, color);
+
+			// push one seed for every run of unfilled pixels above and below
+			for (int ny = seed.y - 1; ny <= seed.y + 1; ny += 2){
+				if (ny < clip.y1 || ny >= clip.y2) continue;
+
+				const short *nrow = FloodRow(ny, w);
+				const uint8_t *nvisited = &floodVisited[ny * w];
+				bool inRun = false;
+
+				for (int i = x1; i <= x2; i++){
+					bool isFillable = (nrow[i] == target && !nvisited[i]);
+
+					if (isFillable && !inRun) floodStack.push_back({i, ny});
+					inRun = isFillable;
+				}
+			}
+		}
+	}
+
+	//=========================================================================
+	// Returns a row of pixel colors for the flood fill. Canvas rows are
+	// read only once per fill and decoded from attributes to the visible
+	// background colors (as in GetPixelColor), surface rows are used
+	// directly.
+	//=========================================================================
+	const short *FloodRow(int y, int w)
+	{
+		if (renderTarget) return renderTarget->Row(y);
+
+		short *row = &floodRows[y * w];
+
+		if (!floodRowRead[y]){
+			for (int x = 0; x < w; x++)
+				row[x] = (Consoler::GetPixelColor(x, y) >> 4) & 15;
+			floodRowRead[y] = 1;
+		}
+
+		return row;
+	}
+
+	//=========================================================================
+	// Returns a / b rounded up (b > 0).
+	//=========================================================================
+	static int64_t CeilDiv(int64_t a, int64_t b)
+	{
+		return (a >= 0) ? (a + b - 1) / b : -(-a / b);
+	}
+
+	//=========================================================================
+	// Returns a / b rounded down (b > 0).
+	//=========================================================================
+	static int64_t FloorDiv(int64_t a, int64_t b)
+	{
+		return (a >= 0) ? a / b : -((-a + b - 1) / b);
+	}
+
+	//=========================================================================
+	// Draws the pixels of a Bresenham line that lie inside the clip.
+	// The line is walked along its major axis A (pixel i is at a1 + i*sa)
+	// and after i pixels it has taken k(i) = floor((2*db*i + da - 1) / (2*da))
+	// steps along its minor axis B. Solving k(i) for the clip edges gives
+	// the first and the last visible pixel, and the error term is advanced
+	// straight to the first one, so the visible pixels are exactly the
+	// pixels of the unclipped line. Consecutive pixels in the same row (or
+	// column for steep lines) are merged into a single span.
+	//=========================================================================
+	void RasterLine(
+		int x1, int y1, int x2, int y2, short color, const Rect &clip
+	){
+		bool isXMajor = abs((int64_t)x2 - x1) >= abs((int64_t)y2 - y1);
+
+		int64_t a1 = isXMajor ? x1 : y1, a2 = isXMajor ? x2 : y2;
+		int64_t b1 = isXMajor ? y1 : x1, b2 = isXMajor ? y2 : x2;
+		int64_t aMin = isXMajor ? clip.x1 : clip.y1;
+		int64_t aMax = (isXMajor ? clip.x2 : clip.y2) - 1;
+		int64_t bMin = isXMajor ? clip.y1 : clip.x1;
+		int64_t bMax = (isXMajor ? clip.y2 : clip.x2) - 1;
+
+		int64_t da = abs(a2 - a1), sa = (a1 < a2) ? 1 : -1;
+		int64_t db = abs(b2 - b1), sb = (b1 < b2) ? 1 : -1;
+
+		// pixels inside the clip along the major axis
+		int64_t i1 = max<int64_t>(0, (sa > 0) ? aMin - a1 : a1 - aMax);
+		int64_t i2 = min<int64_t>(da, (sa > 0) ? aMax - a1 : a1 - aMin);
+
+		// minor steps inside the clip
+		int64_t k1 = max<int64_t>(0, (sb > 0) ? bMin - b1 : b1 - bMax);
+		int64_t k2 = min<int64_t>(db, (sb > 0) ? bMax - b1 : b1 - bMin);
+		if (k1 > k2) return;
+
+		// pixels whose minor steps are between k1 and k2
+		if (db > 0){
+			i1 = max(i1, CeilDiv(2 * da * k1 - da + 1, 2 * db));
+			i2 = min(i2, FloorDiv(2 * da * (k2 + 1) - da, 2 * db));
+		}
+		if (i1 > i2) return;
+
+		// Bresenham state at the first visible pixel
+		int64_t k = (da > 0) ? FloorDiv(2 * db * i1 + da - 1, 2 * da) : 0;
+		int64_t err = 2 * db - da + 2 * db * i1 - 2 * da * k;
+		int64_t run = i1;
+
+		for (int64_t i = i1; ; i++){
+			if (i == i2){
+				DrawLineRun(isXMajor, a1 + sa * run, a1 + sa * i, b1 + sb * k, color);
+				break;
+			}
+			if (err > 0){
+				DrawLineRun(isXMajor, a1 + sa * run, a1 + sa * i, b1 + sb * k, color);
+				k++;
+				run = i + 1;
+				err -= 2 * da;
+			}
+			err += 2 * db;
+		}
+	}
+
+	//=========================================================================
+	// Draws an already clipped run of a line from a1 to a2 (inclusive) on
+	// the major axis at b on the minor axis.
+	//=========================================================================
+	void DrawLineRun(bool isXMajor, int a1, int a2, int b, short color)
+	{
+		if (a1 > a2) swap(a1, a2);
+
+		if (isXMajor) WriteRect(a1, b, a2 - a1 + 1, 1, color);
+		else WriteRect(b, a1, 1, a2 - a1 + 1, color);
+	}
+
+	//=========================================================================
+	// Draws the parts of the row segment from dx1 to dx2 (relative to the
+	// center) that lie within the arc.
+	//=========================================================================
+	void DrawArcRun(
+		int cx, int cy, int dy, int dx1, int dx2,
+		float startAngle, float sweep, short color
+	){
+		int runStart = 0;
+		bool inRun = false;
+
+		for (int dx = dx1; dx <= dx2 + 1; dx++){
+			bool isIn = false;
+
+			if (dx <= dx2){
+				float angle = atan2((float)dy, (float)dx) * 57.2957795f;
+				isIn = fmod(angle - startAngle + 720.0f, 360.0f) <= sweep;
+			}
+
+			if (isIn && !inRun){
+				runStart = dx;
+				inRun = true;
+
+			} else if (!isIn && inRun){
+				FillSpan(cx + runStart, cx + dx - 1, cy + dy, color);
+				inRun = false;
+			}
+		}
+	}
+
+	//=========================================================================
+	// Calculates the half width of every ellipse row from 0 to ry.
+	//=========================================================================
+	void CalcEllipseRows(int rx, int ry)
+	{
+		ellipseRows.resize(ry + 1);
+
+		// doubled coordinates keep the test in integers
+		int64_t a2 = (int64_t)(2 * rx + 1) * (2 * rx + 1);
+		int64_t b2 = (int64_t)(2 * ry + 1) * (2 * ry + 1);
+		int64_t limit = a2 * b2;
+
+		int x = rx;
+		for (int dy = 0; dy <= ry; dy++){
+			int64_t yy = (int64_t)(2 * dy) * (2 * dy) * a2;
+
+			while (x > 0 && (int64_t)(2 * x) * (2 * x) * b2 + yy > limit)
+				x--;
+
+			ellipseRows[dy] = x;
+		}
+	}
+};
+
+#endif